@@ -1,14 +1,46 @@
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
 #include <expected>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <random>
 #include <ranges>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ZPP_SIMD_SSE2 1
+// msvc lets any intrinsic be used, gcc and clang only the enabled ones
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define ZPP_SIMD_AVX2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h> // __cpuid
+#endif
+#endif
+
 namespace zpp {
 namespace init {
 struct compile_env {
@@ -17,8 +49,21 @@ struct compile_env {
     } target_source_version_;
 
     std::filesystem::path source_path_;
+    std::vector<std::filesystem::path> other_sources_; // compiled along with source_path_
+
+    bool dump_layout_; // -dump-layout
+    bool pack_fields_; // -fpack-fields
+    bool dump_ir_; // -dump-ir
+    bool vectorize_; // -fno-vectorize
 
-    compile_env() : target_source_version_(ZppVersion::Zpp24), source_path_{} {}
+    enum class DiagFormat {
+        Text,
+        Json // one object per line
+    } diag_format_; // -fdiagnostics-format=
+
+    compile_env() : target_source_version_(ZppVersion::Zpp24), source_path_{}, other_sources_{},
+        dump_layout_(false), pack_fields_(false), dump_ir_(false), vectorize_(true),
+        diag_format_(DiagFormat::Text) {}
 
     friend std::ostream& operator<<(std::ostream& os, const compile_env& self) noexcept {
         switch (self.target_source_version_) {
@@ -47,6 +92,10 @@ struct cl {
            });
     }
 
+    bool has_flag(std::string_view f) const noexcept {
+        return std::ranges::find(argv_, f) != argv_.end();
+    }
+
     // let only source file doesn't start with - (flag prefix)
     bool has_source() const noexcept {
         return std::ranges::any_of(argv_,
@@ -66,6 +115,11 @@ struct cl {
         else {
             env.source_path_ = *argv_.begin();
             argv_.erase(argv_.begin()); // the flag is used, so drop it
+
+            auto rest = std::ranges::stable_partition(argv_,
+                [](const std::string& s) { return s.starts_with('-'); });
+            env.other_sources_.assign(rest.begin(), rest.end());
+            argv_.erase(rest.begin(), rest.end());
         }
         // language version parsing
         if (const auto r = std::ranges::find_if(argv_,
@@ -78,6 +132,22 @@ struct cl {
             else
                 return std::unexpected<std::exception>("unknown language version");
         }
+        if (const auto r = std::ranges::find_if(argv_,
+            [](const auto& s) { return s.starts_with("-fdiagnostics-format="); }); r != argv_.end()) {
+            const auto fmt = r->substr(strlen("-fdiagnostics-format="));
+
+            if (fmt == "text")
+                env.diag_format_ = init::compile_env::DiagFormat::Text;
+            else if (fmt == "json")
+                env.diag_format_ = init::compile_env::DiagFormat::Json;
+            else
+                return std::unexpected<std::exception>("unknown diagnostics format");
+        }
+
+        env.dump_layout_ = has_flag("-dump-layout");
+        env.pack_fields_ = has_flag("-fpack-fields");
+        env.dump_ir_ = has_flag("-dump-ir");
+        env.vectorize_ = !has_flag("-fno-vectorize");
 
         ; // other options parsing here...
 
@@ -87,6 +157,108 @@ struct cl {
 
 } // ns pre_init
 
+namespace io {
+// a fixed set of threads running posted jobs, in posting order
+class ThreadPool {
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stop_;
+    std::vector<std::jthread> workers_;
+public:
+    ThreadPool(std::size_t n) noexcept : m_{}, cv_{}, jobs_{}, stop_(false), workers_{} {
+        for (; n; --n)
+            workers_.emplace_back([this] {
+                for (;;) {
+                    std::unique_lock lk{ m_ };
+                    cv_.wait(lk, [this] { return stop_ || !jobs_.empty(); });
+                    if (jobs_.empty()) return; // stopped and drained
+                    auto job = std::move(jobs_.front());
+                    jobs_.pop_front();
+                    lk.unlock();
+                    job();
+                }
+            });
+    }
+
+    ~ThreadPool() noexcept {
+        {
+            std::lock_guard lk{ m_ };
+            stop_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void post(std::function<void()>&& job) noexcept {
+        {
+            std::lock_guard lk{ m_ };
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+};
+
+// text mode, as tokenize_file reads, so crlf sources lex the same either way.
+// the file size is an upper bound of what is read then
+auto read_all(const std::filesystem::path& file_path) noexcept
+    -> std::expected<std::string, std::exception> {
+    std::ifstream ifs(file_path, std::ios::in);
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(file_path, ec);
+
+    if (!ifs.is_open() || ec)
+        return std::unexpected<std::exception>(
+            ("Failed to open file, " + file_path.string() + '\n').c_str());
+
+    std::string bytes(size, '\0');
+    ifs.read(bytes.data(), static_cast<std::streamsize>(size));
+    bytes.resize(static_cast<std::size_t>(ifs.gcount()));
+    return bytes;
+}
+
+// reads in flight at once. the io threads only wait on the disk,
+// so there are as many as reads to keep queued, not as cores
+constexpr std::size_t io_queue_depth = 32;
+
+// co_await ReadFile{ io, cpu, path } suspends until the whole file is read
+// on one of the io threads, and resumes on one of the cpu threads, so the
+// io thread goes on to the next read at once.
+// there is no io_uring on windows, so the blocking read runs on the io pool
+struct ReadFile {
+    ThreadPool& io_;
+    ThreadPool& cpu_;
+    std::filesystem::path path_;
+    std::expected<std::string, std::exception> bytes_{};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+        io_.post([this, h] {
+            bytes_ = read_all(path_);
+            // the awaiter may be gone once h is resumed
+            cpu_.post([h] { h.resume(); });
+        });
+    }
+
+    auto await_resume() noexcept {
+        return std::move(bytes_);
+    }
+};
+
+// a coroutine nobody waits on; it frees itself once done
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+} // ns io
+
 namespace tok {
 enum class Token {
     Unknown,
@@ -97,7 +269,7 @@ enum class Token {
     Separator, // ::
     TypeOf, // :
     Paren, // ()
-    Bracket, // {}
+    Bracket, // {} []
     Comma,
     From // from
 };
@@ -135,19 +307,17 @@ constexpr auto stringify_tok(Token t) noexcept -> std::string
 }
 
 namespace details {
-auto _readWord(std::ifstream& ifs)
+auto _readWord(std::istream& ifs)
     -> std::pair<tok::Token, std::string> {
     using tok::Token;
 
-    static std::string buf{}, ret;
+    // files may be lexed on several threads at once
+    thread_local std::string buf{}, ret;
     ret = {};
 CHK_BUF:
     if (buf.empty()) {
-        std::string _s;
-        std::getline(ifs, _s);
-        buf = _s;
-    
-        if (ifs.eof())
+        // the last line may have no newline, so only stop once nothing is read
+        if (!std::getline(ifs, buf))
             return { Token::Eof, "" };
 
         goto CHK_BUF;
@@ -211,7 +381,7 @@ CHK_BUF:
             buf.erase(0, 1);
             return { Token::Paren, {c} };
         }
-        if (buf[0] == '{' || buf[0] == '}') {
+        if (buf[0] == '{' || buf[0] == '}' || buf[0] == '[' || buf[0] == ']') {
             auto c = buf[0];
             buf.erase(0, 1);
             return { Token::Bracket, {c} };
@@ -222,6 +392,18 @@ CHK_BUF:
             return { Token::Comma, {c} };
         }
 
+        // operators, longest first
+        for (std::string_view op : { "==", "!=", "<=", ">=", "<<", ">>" })
+            if (buf.starts_with(op)) {
+                buf.erase(0, 2);
+                return { Token::Operator, std::string{ op } };
+            }
+        if (std::string_view{ "+-*/%&|^<>=!" }.find(buf[0]) != std::string_view::npos) {
+            auto c = buf[0];
+            buf.erase(0, 1);
+            return { Token::Operator, {c} };
+        }
+
         ret += buf[0];
         buf.erase(0, 1);
         auto [t, w] = _readWord(ifs);
@@ -232,15 +414,7 @@ CHK_BUF:
 }
 } // ns details
 
-auto tokenize_file(const std::filesystem::path& file_path) noexcept ->
-std::expected<std::vector<std::pair<Token, std::string>>, std::exception> {
-    std::ifstream ifs(file_path, std::ios::in);
-    std::string s;
-    
-    if (!ifs.is_open())
-        return std::unexpected<std::exception>(
-            ("Failed to open file, " + file_path.string() + '\n').c_str());
-
+auto tokenize(std::istream& ifs) noexcept -> std::vector<std::pair<Token, std::string>> {
     auto readWord = [&]{ return details::_readWord(ifs); };
 
     std::vector<std::pair<Token, std::string>> toks{};
@@ -252,11 +426,629 @@ TOKENIZE_LOOP:
     }
     return toks;
 }
+
+auto tokenize_file(const std::filesystem::path& file_path) noexcept ->
+std::expected<std::vector<std::pair<Token, std::string>>, std::exception> {
+    std::ifstream ifs(file_path, std::ios::in);
+
+    if (!ifs.is_open())
+        return std::unexpected<std::exception>(
+            ("Failed to open file, " + file_path.string() + '\n').c_str());
+
+    return tokenize(ifs);
+}
+
+namespace details {
+io::Detached _tokenizeAsync(io::ThreadPool& io, io::ThreadPool& cpu, std::filesystem::path file_path,
+    std::expected<std::vector<std::pair<Token, std::string>>, std::exception>& out, std::latch& done) {
+    io::ReadFile read{ io, cpu, std::move(file_path) };
+    auto bytes = co_await read;
+
+    if (bytes.has_value()) {
+        std::istringstream iss(std::move(bytes.value()));
+        out = tokenize(iss);
+    }
+    else out = std::unexpected(bytes.error());
+    done.count_down();
+}
+} // ns details
+
+// all the reads are queued at once, up to io_queue_depth of them in flight,
+// and each file is lexed on a cpu thread as soon as its bytes are read,
+// while the io threads go on reading the others
+auto tokenize_files(std::span<const std::filesystem::path> file_paths) noexcept ->
+std::vector<std::expected<std::vector<std::pair<Token, std::string>>, std::exception>> {
+    std::vector<std::expected<std::vector<std::pair<Token, std::string>>, std::exception>> toks(file_paths.size());
+    std::latch done{ static_cast<std::ptrdiff_t>(file_paths.size()) };
+
+    // io is joined first, as its threads post to cpu until their last read
+    io::ThreadPool cpu{ std::min<std::size_t>(file_paths.size(), std::max(1u, std::thread::hardware_concurrency())) };
+    io::ThreadPool io{ std::min(file_paths.size(), io::io_queue_depth) };
+    for (std::size_t i = 0; i < file_paths.size(); ++i)
+        details::_tokenizeAsync(io, cpu, file_paths[i], toks[i], done);
+    done.wait();
+
+    return toks;
+}
 } // ns tok
 
 namespace code {
 
-class CodeBlock {};
+namespace simd {
+enum class BinOp {
+    Add, Sub, Mul, Div, Mod,
+    And, Or, Xor, Shl, Shr,
+    Eq, Ne, Lt, Gt, Le, Ge,
+    Min, Max,
+    Bad
+};
+
+constexpr BinOp binop_of(std::string_view s) noexcept {
+    using enum BinOp;
+    constexpr std::pair<std::string_view, BinOp> ops[]{
+        { "+", Add }, { "-", Sub }, { "*", Mul }, { "/", Div }, { "%", Mod },
+        { "&", And }, { "|", Or }, { "^", Xor }, { "<<", Shl }, { ">>", Shr },
+        { "==", Eq }, { "!=", Ne }, { "<", Lt }, { ">", Gt }, { "<=", Le }, { ">=", Ge },
+        { "min", Min }, { "max", Max },
+    };
+    for (auto [k, v] : ops)
+        if (k == s) return v;
+    return Bad;
+}
+
+constexpr bool is_cmp(BinOp op) noexcept {
+    return op >= BinOp::Eq && op <= BinOp::Ge;
+}
+
+// byte width of an integer type that loops can be vectorized over, 0 otherwise
+constexpr std::size_t int_width(std::string_view ty) noexcept {
+    return ty == "i8" ? 1 : ty == "i16" ? 2 : ty == "i32" ? 4 : ty == "i64" ? 8 : 0;
+}
+
+// whether imm is a value of the integer type ty. immediates are never
+// truncated, so one that is not cannot be used over ty
+constexpr bool fits(std::int64_t imm, std::string_view ty) noexcept {
+    const auto w = int_width(ty);
+    if (w == 0) return false;
+    if (w == 8) return true;
+    const auto lim = std::int64_t{ 1 } << (w * 8 - 1);
+    return imm >= -lim && imm < lim;
+}
+
+// two's complement wrapping arithmetic. comparisons give 1 or 0,
+// and shifting by the width or more shifts every bit out
+template <typename T>
+constexpr T apply(T a, BinOp op, T b) noexcept {
+    using U = std::uint64_t;
+    constexpr T bits = sizeof(T) * 8;
+
+    switch (op) {
+    case BinOp::Add: return static_cast<T>(U(a) + U(b));
+    case BinOp::Sub: return static_cast<T>(U(a) - U(b));
+    case BinOp::Mul: return static_cast<T>(U(a) * U(b));
+    case BinOp::Div: return b == 0 ? T{} : b == -1 ? static_cast<T>(U{} - U(a)) : static_cast<T>(a / b);
+    case BinOp::Mod: return b == 0 || b == -1 ? T{} : static_cast<T>(a % b);
+    case BinOp::And: return static_cast<T>(a & b);
+    case BinOp::Or: return static_cast<T>(a | b);
+    case BinOp::Xor: return static_cast<T>(a ^ b);
+    case BinOp::Shl: return b < 0 || b >= bits ? T{} : static_cast<T>(U(a) << b);
+    case BinOp::Shr: return b < 0 || b >= bits ? static_cast<T>(a < 0 ? -1 : 0) : static_cast<T>(a >> b);
+    case BinOp::Eq: return a == b;
+    case BinOp::Ne: return a != b;
+    case BinOp::Lt: return a < b;
+    case BinOp::Gt: return a > b;
+    case BinOp::Le: return a <= b;
+    case BinOp::Ge: return a >= b;
+    case BinOp::Min: return std::min(a, b);
+    case BinOp::Max: return std::max(a, b);
+    default:
+        ;
+    }
+    return T{};
+}
+
+// starting value of a reduction
+template <typename T>
+constexpr T identity(BinOp op) noexcept {
+    switch (op) {
+    case BinOp::Mul: return 1;
+    case BinOp::And: return -1;
+    case BinOp::Min: return std::numeric_limits<T>::max();
+    case BinOp::Max: return std::numeric_limits<T>::min();
+    default:
+        ;
+    }
+    return T{};
+}
+
+template <typename F>
+void with_binop(BinOp op, F&& f) {
+    using enum BinOp;
+    switch (op) {
+    case Add: f.template operator()<Add>(); break;
+    case Sub: f.template operator()<Sub>(); break;
+    case Mul: f.template operator()<Mul>(); break;
+    case Div: f.template operator()<Div>(); break;
+    case Mod: f.template operator()<Mod>(); break;
+    case And: f.template operator()<And>(); break;
+    case Or: f.template operator()<Or>(); break;
+    case Xor: f.template operator()<Xor>(); break;
+    case Shl: f.template operator()<Shl>(); break;
+    case Shr: f.template operator()<Shr>(); break;
+    case Eq: f.template operator()<Eq>(); break;
+    case Ne: f.template operator()<Ne>(); break;
+    case Lt: f.template operator()<Lt>(); break;
+    case Gt: f.template operator()<Gt>(); break;
+    case Le: f.template operator()<Le>(); break;
+    case Ge: f.template operator()<Ge>(); break;
+    case Min: f.template operator()<Min>(); break;
+    case Max: f.template operator()<Max>(); break;
+    default:
+        ;
+    }
+}
+
+// an isa is the register type, its width, and which (type, op) it has an
+// instruction for. ne, lt, le and ge are derived from eq and gt.
+// everything else is left to the scalar loop after the vector one.
+struct scalar {
+    template <typename T, BinOp O>
+    static constexpr bool has = false;
+};
+
+#if ZPP_SIMD_SSE2
+using count_t = __m128i;
+
+inline count_t shift_count(std::int64_t n) noexcept {
+    return _mm_cvtsi32_si128(n < 0 || n > 64 ? 64 : static_cast<int>(n));
+}
+#else
+using count_t = int;
+
+inline count_t shift_count(std::int64_t) noexcept {
+    return 0;
+}
+#endif
+
+#if ZPP_SIMD_SSE2
+struct sse2 {
+    using reg = __m128i;
+    static constexpr std::size_t bytes = 16;
+
+    template <typename T, BinOp O>
+    static constexpr bool has = [] {
+        using enum BinOp;
+        constexpr auto w = sizeof(T);
+        switch (O) {
+        case Add: case Sub: case And: case Or: case Xor: return true;
+        case Mul: return w == 2;
+        case Shl: return w > 1;
+        case Shr: return w == 2 || w == 4;
+        case Eq: case Ne: case Lt: case Gt: case Le: case Ge: return w < 8;
+        case Min: case Max: return w == 2;
+        default: return false;
+        }
+    }();
+
+    static reg load(const void* p) noexcept { return _mm_loadu_si128(static_cast<const reg*>(p)); }
+    static void store(void* p, reg v) noexcept { _mm_storeu_si128(static_cast<reg*>(p), v); }
+    static reg zero() noexcept { return _mm_setzero_si128(); }
+    static reg ones() noexcept { return _mm_set1_epi32(-1); }
+    static reg and_(reg a, reg b) noexcept { return _mm_and_si128(a, b); }
+    static reg andnot(reg a, reg b) noexcept { return _mm_andnot_si128(a, b); }
+    static reg or_(reg a, reg b) noexcept { return _mm_or_si128(a, b); }
+    static reg xor_(reg a, reg b) noexcept { return _mm_xor_si128(a, b); }
+
+    template <typename T>
+    static reg set1(T v) noexcept {
+        if constexpr (sizeof(T) == 1) return _mm_set1_epi8(v);
+        else if constexpr (sizeof(T) == 2) return _mm_set1_epi16(v);
+        else if constexpr (sizeof(T) == 4) return _mm_set1_epi32(v);
+        else return _mm_set1_epi64x(v);
+    }
+
+    template <typename T, BinOp O>
+    static reg op(reg a, reg b, count_t c) noexcept {
+        using enum BinOp;
+        constexpr auto w = sizeof(T);
+        if constexpr (O == Add) {
+            if constexpr (w == 1) return _mm_add_epi8(a, b);
+            else if constexpr (w == 2) return _mm_add_epi16(a, b);
+            else if constexpr (w == 4) return _mm_add_epi32(a, b);
+            else return _mm_add_epi64(a, b);
+        }
+        else if constexpr (O == Sub) {
+            if constexpr (w == 1) return _mm_sub_epi8(a, b);
+            else if constexpr (w == 2) return _mm_sub_epi16(a, b);
+            else if constexpr (w == 4) return _mm_sub_epi32(a, b);
+            else return _mm_sub_epi64(a, b);
+        }
+        else if constexpr (O == Mul) return _mm_mullo_epi16(a, b);
+        else if constexpr (O == And) return and_(a, b);
+        else if constexpr (O == Or) return or_(a, b);
+        else if constexpr (O == Xor) return xor_(a, b);
+        else if constexpr (O == Shl) {
+            if constexpr (w == 2) return _mm_sll_epi16(a, c);
+            else if constexpr (w == 4) return _mm_sll_epi32(a, c);
+            else return _mm_sll_epi64(a, c);
+        }
+        else if constexpr (O == Shr) {
+            if constexpr (w == 2) return _mm_sra_epi16(a, c);
+            else return _mm_sra_epi32(a, c);
+        }
+        else if constexpr (O == Eq) {
+            if constexpr (w == 1) return _mm_cmpeq_epi8(a, b);
+            else if constexpr (w == 2) return _mm_cmpeq_epi16(a, b);
+            else return _mm_cmpeq_epi32(a, b);
+        }
+        else if constexpr (O == Gt) {
+            if constexpr (w == 1) return _mm_cmpgt_epi8(a, b);
+            else if constexpr (w == 2) return _mm_cmpgt_epi16(a, b);
+            else return _mm_cmpgt_epi32(a, b);
+        }
+        else if constexpr (O == Min) return _mm_min_epi16(a, b);
+        else return _mm_max_epi16(a, b);
+    }
+};
+#endif
+
+#if ZPP_SIMD_AVX2
+struct avx2 {
+    using reg = __m256i;
+    static constexpr std::size_t bytes = 32;
+
+    template <typename T, BinOp O>
+    static constexpr bool has = [] {
+        using enum BinOp;
+        constexpr auto w = sizeof(T);
+        switch (O) {
+        case Add: case Sub: case And: case Or: case Xor: return true;
+        case Mul: return w == 2 || w == 4;
+        case Shl: return w > 1;
+        case Shr: return w == 2 || w == 4;
+        case Eq: case Ne: case Lt: case Gt: case Le: case Ge: return true;
+        case Min: case Max: return w < 8;
+        default: return false;
+        }
+    }();
+
+    static reg load(const void* p) noexcept { return _mm256_loadu_si256(static_cast<const reg*>(p)); }
+    static void store(void* p, reg v) noexcept { _mm256_storeu_si256(static_cast<reg*>(p), v); }
+    static reg zero() noexcept { return _mm256_setzero_si256(); }
+    static reg ones() noexcept { return _mm256_set1_epi32(-1); }
+    static reg and_(reg a, reg b) noexcept { return _mm256_and_si256(a, b); }
+    static reg andnot(reg a, reg b) noexcept { return _mm256_andnot_si256(a, b); }
+    static reg or_(reg a, reg b) noexcept { return _mm256_or_si256(a, b); }
+    static reg xor_(reg a, reg b) noexcept { return _mm256_xor_si256(a, b); }
+
+    template <typename T>
+    static reg set1(T v) noexcept {
+        if constexpr (sizeof(T) == 1) return _mm256_set1_epi8(v);
+        else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16(v);
+        else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32(v);
+        else return _mm256_set1_epi64x(v);
+    }
+
+    template <typename T, BinOp O>
+    static reg op(reg a, reg b, count_t c) noexcept {
+        using enum BinOp;
+        constexpr auto w = sizeof(T);
+        if constexpr (O == Add) {
+            if constexpr (w == 1) return _mm256_add_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_add_epi16(a, b);
+            else if constexpr (w == 4) return _mm256_add_epi32(a, b);
+            else return _mm256_add_epi64(a, b);
+        }
+        else if constexpr (O == Sub) {
+            if constexpr (w == 1) return _mm256_sub_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_sub_epi16(a, b);
+            else if constexpr (w == 4) return _mm256_sub_epi32(a, b);
+            else return _mm256_sub_epi64(a, b);
+        }
+        else if constexpr (O == Mul) {
+            if constexpr (w == 2) return _mm256_mullo_epi16(a, b);
+            else return _mm256_mullo_epi32(a, b);
+        }
+        else if constexpr (O == And) return and_(a, b);
+        else if constexpr (O == Or) return or_(a, b);
+        else if constexpr (O == Xor) return xor_(a, b);
+        else if constexpr (O == Shl) {
+            if constexpr (w == 2) return _mm256_sll_epi16(a, c);
+            else if constexpr (w == 4) return _mm256_sll_epi32(a, c);
+            else return _mm256_sll_epi64(a, c);
+        }
+        else if constexpr (O == Shr) {
+            if constexpr (w == 2) return _mm256_sra_epi16(a, c);
+            else return _mm256_sra_epi32(a, c);
+        }
+        else if constexpr (O == Eq) {
+            if constexpr (w == 1) return _mm256_cmpeq_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_cmpeq_epi16(a, b);
+            else if constexpr (w == 4) return _mm256_cmpeq_epi32(a, b);
+            else return _mm256_cmpeq_epi64(a, b);
+        }
+        else if constexpr (O == Gt) {
+            if constexpr (w == 1) return _mm256_cmpgt_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_cmpgt_epi16(a, b);
+            else if constexpr (w == 4) return _mm256_cmpgt_epi32(a, b);
+            else return _mm256_cmpgt_epi64(a, b);
+        }
+        else if constexpr (O == Min) {
+            if constexpr (w == 1) return _mm256_min_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_min_epi16(a, b);
+            else return _mm256_min_epi32(a, b);
+        }
+        else {
+            if constexpr (w == 1) return _mm256_max_epi8(a, b);
+            else if constexpr (w == 2) return _mm256_max_epi16(a, b);
+            else return _mm256_max_epi32(a, b);
+        }
+    }
+};
+#endif
+
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+inline Isa detect_isa() noexcept {
+#if ZPP_SIMD_AVX2
+#if defined(_MSC_VER)
+    int r[4]{};
+    __cpuid(r, 0);
+    if (r[0] >= 7) {
+        __cpuid(r, 1);
+        // avx and osxsave, and the os saving the ymm registers
+        if ((r[2] & (1 << 27)) && (r[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(r, 7, 0);
+            if (r[1] & (1 << 5)) return Isa::Avx2;
+        }
+    }
+#else
+    if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+#endif
+#endif
+#if ZPP_SIMD_SSE2
+    return Isa::Sse2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+namespace details {
+inline Isa& current_isa() noexcept {
+    static Isa i = detect_isa();
+    return i;
+}
+} // ns details
+
+// the isa every kernel runs with
+inline Isa isa() noexcept {
+    return details::current_isa();
+}
+
+// runs the kernels with i, or the best detected isa below it, from now on
+inline void use_isa(Isa i) noexcept {
+    details::current_isa() = std::min(i, detect_isa());
+}
+
+constexpr auto stringify_isa(Isa i) noexcept -> std::string {
+    switch (i) {
+    case Isa::Sse2:
+        return "SSE2";
+    case Isa::Avx2:
+        return "AVX2";
+    default:
+        ;
+    }
+    return "scalar";
+}
+
+namespace details {
+template <typename V, typename T, BinOp O>
+typename V::reg eval(typename V::reg a, typename V::reg b, count_t c) noexcept {
+    using enum BinOp;
+    if constexpr (O == Ne) return V::xor_(V::template op<T, Eq>(a, b, c), V::ones());
+    else if constexpr (O == Lt) return V::template op<T, Gt>(b, a, c);
+    else if constexpr (O == Le) return V::xor_(V::template op<T, Gt>(a, b, c), V::ones());
+    else if constexpr (O == Ge) return V::xor_(V::template op<T, Gt>(b, a, c), V::ones());
+    else return V::template op<T, O>(a, b, c);
+}
+
+// p[i] = p[i] O imm
+template <typename V, typename T, BinOp O>
+void map(T* p, std::size_t n, T imm) noexcept {
+    std::size_t i{};
+    if constexpr (V::template has<T, O>) {
+        constexpr auto lanes = V::bytes / sizeof(T);
+        const auto b = V::template set1<T>(imm), one = V::template set1<T>(1);
+        const auto c = shift_count(imm);
+        for (; i + lanes <= n; i += lanes) {
+            auto r = eval<V, T, O>(V::load(p + i), b, c);
+            if constexpr (is_cmp(O)) r = V::and_(r, one);
+            V::store(p + i, r);
+        }
+    }
+    for (; i < n; ++i) p[i] = apply(p[i], O, imm);
+}
+
+// clears mask[i] unless (p[i] O imm) != 0
+template <typename V, typename T, BinOp O>
+void guard(const T* p, T* mask, std::size_t n, T imm) noexcept {
+    std::size_t i{};
+    if constexpr (V::template has<T, O> && V::template has<T, BinOp::Eq>) {
+        constexpr auto lanes = V::bytes / sizeof(T);
+        const auto b = V::template set1<T>(imm), z = V::zero();
+        const auto c = shift_count(imm);
+        for (; i + lanes <= n; i += lanes) {
+            auto r = eval<V, T, O>(V::load(p + i), b, c);
+            if constexpr (!is_cmp(O)) r = eval<V, T, BinOp::Ne>(r, z, c);
+            V::store(mask + i, V::and_(V::load(mask + i), r));
+        }
+    }
+    // without a branch, which random elements would mispredict half the time
+    for (; i < n; ++i)
+        mask[i] = static_cast<T>(mask[i] & -static_cast<T>(apply(p[i], O, imm) != 0));
+}
+
+// folds p[i] with O, skipping the elements whose mask is cleared
+template <typename V, typename T, BinOp O>
+T reduce(const T* p, const T* mask, std::size_t n) noexcept {
+    T acc = identity<T>(O);
+    std::size_t i{};
+    if constexpr (V::template has<T, O>) {
+        constexpr auto lanes = V::bytes / sizeof(T);
+        const auto id = V::template set1<T>(acc);
+        const auto c = shift_count(0);
+        auto r = id;
+        for (; i + lanes <= n; i += lanes) {
+            auto v = V::load(p + i);
+            if (mask) {
+                const auto m = V::load(mask + i);
+                v = V::or_(V::and_(m, v), V::andnot(m, id));
+            }
+            r = eval<V, T, O>(r, v, c);
+        }
+        alignas(32) T part[lanes];
+        V::store(part, r);
+        for (auto x : part) acc = apply(acc, O, x);
+    }
+    // masked out elements fold the identity in, as in the vector loop
+    const auto id = identity<T>(O);
+    for (; i < n; ++i)
+        acc = apply(acc, O, !mask || mask[i] ? p[i] : id);
+    return acc;
+}
+
+template <typename F>
+void with_isa(F&& f) {
+    switch (isa()) {
+#if ZPP_SIMD_AVX2
+    case Isa::Avx2:
+        return f(avx2{});
+#endif
+#if ZPP_SIMD_SSE2
+    case Isa::Sse2:
+        return f(sse2{});
+#endif
+    default:
+        return f(scalar{});
+    }
+}
+} // ns details
+
+template <typename T>
+void map(T* p, std::size_t n, BinOp op, T imm) noexcept {
+    with_binop(op, [&]<BinOp O>() {
+        details::with_isa([&]<typename V>(V) { details::map<V, T, O>(p, n, imm); });
+    });
+}
+
+template <typename T>
+void guard(const T* p, T* mask, std::size_t n, BinOp op, T imm) noexcept {
+    with_binop(op, [&]<BinOp O>() {
+        details::with_isa([&]<typename V>(V) { details::guard<V, T, O>(p, mask, n, imm); });
+    });
+}
+
+template <typename T>
+T reduce(const T* p, const T* mask, std::size_t n, BinOp op) noexcept {
+    T acc{};
+    with_binop(op, [&]<BinOp O>() {
+        details::with_isa([&]<typename V>(V) { acc = details::reduce<V, T, O>(p, mask, n); });
+    });
+    return acc;
+}
+} // ns simd
+
+// lowered code, a flat list of instructions. loops are bracketed by
+// LoopBegin/LoopEnd and their bodies work on the current element `_`
+class CodeBlock {
+public:
+    enum class Op {
+        Set, // sym_ = arg_
+        Ret, // return sym_
+        LoopBegin, // for each _ in sym_, or in the enclosing `_` when sym_ is "_"
+        LoopEnd,
+        Map, // _ = _ arg_ imm_, or _ = sym_(_)
+        Guard, // skip _ unless (_ arg_ imm_) != 0, or sym_(_)
+        Take, // leave the whole loop nest once imm_ elements went by
+        Yield, // append _ to sym_
+        Reduce, // sym_ = sym_ arg_ _
+        VecLoopBegin // LoopBegin taking imm_ elements at once, up to the last full vector.
+                     // the remainder is left to a following LoopBegin with the same imm_
+    };
+
+    struct Instr {
+        Op op_;
+        std::string sym_;
+        std::string arg_;
+        std::int64_t imm_;
+        std::string ty_; // element type, inside loops
+    };
+
+    std::vector<Instr> insts_;
+
+    void emit(Instr&& i) noexcept {
+        insts_.push_back(std::move(i));
+    }
+
+    void append(CodeBlock&& cb) noexcept {
+        std::ranges::move(cb.insts_, std::back_inserter(insts_));
+    }
+
+    std::ostream& dump(std::ostream& os) const noexcept {
+        auto fn = [](const Instr& i) {
+            return i.sym_.empty() ? "_ " + i.arg_ + ' ' + std::to_string(i.imm_) : i.sym_ + "(_)";
+        };
+        std::size_t depth = 1;
+        for (const auto& i : insts_) {
+            if (i.op_ == Op::LoopEnd) --depth;
+            os << std::string(depth * 2, ' ');
+            switch (i.op_) {
+            case Op::Set:
+                os << i.sym_ << " = " << i.arg_;
+                break;
+            case Op::Ret:
+                os << "ret " << i.sym_;
+                break;
+            case Op::LoopBegin:
+                os << "loop _: " << i.ty_ << " in " << i.sym_;
+                if (i.imm_) os << " (rest of x" << i.imm_ << ')';
+                ++depth;
+                break;
+            case Op::VecLoopBegin:
+                os << "vloop _: " << i.ty_ << " x" << i.imm_ << " in " << i.sym_;
+                ++depth;
+                break;
+            case Op::LoopEnd:
+                os << "end";
+                break;
+            case Op::Map:
+                os << "map _ = " << fn(i);
+                break;
+            case Op::Guard:
+                os << "guard " << fn(i);
+                break;
+            case Op::Take:
+                os << "take " << i.imm_;
+                break;
+            case Op::Yield:
+                os << "yield _ -> " << i.sym_;
+                break;
+            case Op::Reduce:
+                os << "reduce " << i.sym_ << ' ' << i.arg_ << "= _";
+                break;
+            default:
+                ;
+            }
+            os << '\n';
+        }
+        return os;
+    }
+};
 
 class AST {
 public:
@@ -302,8 +1094,9 @@ public:
     const std::string name_;
     const std::string ret_ty_;
     const farg_t farg_;
+    std::vector<std::unique_ptr<AST>> body_;
     Function(std::string&& name, std::string&& ret_ty, farg_t&& args) noexcept
-        : AST{}, name_(std::move(name)), ret_ty_(std::move(ret_ty)), farg_(std::move(args))
+        : AST{}, name_(std::move(name)), ret_ty_(std::move(ret_ty)), farg_(std::move(args)), body_{}
     {}
     ~Function() noexcept override = default;
 
@@ -318,7 +1111,10 @@ public:
     }
 
     CodeBlock gen_code() const noexcept override {
-        return CodeBlock{};
+        CodeBlock cb{};
+        for (const auto& stmt : body_)
+            cb.append(stmt->gen_code());
+        return cb;
     }
 };
 
@@ -340,66 +1136,811 @@ public:
     }
 };
 
-class Expression : public AST {
-public:
-    virtual ~Expression() noexcept = default;
+enum class ErrCode : std::uint16_t {
+    NoMoreToken,
+    ExpectedToken,
+    Expected,
+    Unexpected,
+    UnexpectedToken,
+    ExpectedInteger,
+    ExpectedValue,
+    NotARange,
+    JoinNonRange,
+    UnknownAdaptor,
+    UnknownReduction,
+    DivisionByZero,
+    ImmOutOfRange,
+    NegativeTake,
+    NotAnInteger,
+    ReduceNotLast,
+    Redefinition,
+    UnknownBase,
+    UnknownType
+};
 
-    std::ostream& dump_info(std::ostream& os) const noexcept override = 0;
+// name and message of every ErrCode, in order. {} takes the next argument
+constexpr std::pair<std::string_view, std::string_view> err_infos[]{
+    { "NoMoreToken", "No more token" },
+    { "ExpectedToken", "Expected {}, but {}" },
+    { "Expected", "Expected '{}'" },
+    { "Unexpected", "Unexpected '{}'" },
+    { "UnexpectedToken", "Unexpected {}, expected '{}'" },
+    { "ExpectedInteger", "Expected an integer, but {}" },
+    { "ExpectedValue", "Expected a value, but {}" },
+    { "NotARange", "'{}' is not a range" },
+    { "JoinNonRange", "join over a range of non-range elements" },
+    { "UnknownAdaptor", "Unknown range adaptor '{}'" },
+    { "UnknownReduction", "Unknown reduction '{}'" },
+    { "DivisionByZero", "Division by zero" },
+    { "ImmOutOfRange", "{} does not fit in {}" },
+    { "NegativeTake", "take of a negative count {}" },
+    { "NotAnInteger", "{} needs i8, i16, i32 or i64 elements, but they are {}" },
+    { "ReduceNotLast", "reduce must be the last stage" },
+    { "Redefinition", "Redefinition of class '{}'" },
+    { "UnknownBase", "Unknown base class '{}'" },
+    { "UnknownType", "Unknown type '{}'" },
+};
+static_assert(std::size(err_infos) == static_cast<std::size_t>(ErrCode::UnknownType) + 1);
 
-    CodeBlock gen_code() const noexcept override = 0;
+constexpr auto stringify_err(ErrCode c) noexcept -> std::string_view {
+    return err_infos[static_cast<std::size_t>(c)].first;
+}
+
+namespace layout {
+constexpr std::size_t cache_line_size = 64;
+
+// the error, and the class or type it is about
+using LayoutError = std::pair<ErrCode, std::string>;
+
+struct Field {
+    std::string name_;
+    std::string type_;
+    bool hot_; // hot name: ty
 };
 
-class EAssignVal;
+struct FieldSlot {
+    Field field_;
+    std::size_t offset_;
+    std::size_t size_;
+    std::size_t align_;
+};
 
-class EDeclareVar : public Expression {
-    const std::string name_;
-    const std::string type_;
-    std::unique_ptr<Expression> val_;
-public:
-    EDeclareVar(EDeclareVar&& dv) noexcept
-        : name_(dv.name_), type_(dv.type_), val_(std::move(dv.val_)) {}
-    EDeclareVar(std::string&& name, std::string&& type, std::unique_ptr<Expression> val = nullptr) noexcept
-        : name_(std::move(name)), type_(std::move(type)), val_(std::move(val)) {}
-    ~EDeclareVar() noexcept override = default;
+struct BaseSlot {
+    std::string name_;
+    std::size_t offset_;
+    std::size_t size_; // 0 for an empty base
+};
 
-    std::ostream& dump_info(std::ostream& os) const noexcept override {
-        return os;
+struct Layout {
+    std::string name_;
+    std::vector<BaseSlot> bases_;
+    std::vector<FieldSlot> fields_;
+    std::size_t size_;
+    std::size_t align_;
+
+    // an empty class still takes a byte as an object, but none as a base
+    bool is_empty() const noexcept {
+        return fields_.empty()
+            && std::ranges::all_of(bases_, [](const auto& b) { return b.size_ == 0; });
     }
 
-    CodeBlock gen_code() const noexcept override {
-        return CodeBlock{};
+    std::size_t padding() const noexcept {
+        if (is_empty()) return 0;
+        std::size_t used{};
+        for (const auto& b : bases_) used += b.size_;
+        for (const auto& f : fields_) used += f.size_;
+        return size_ - used;
     }
 
-    friend EAssignVal;
-};
+    // the most cache lines the bytes [off, off + n) can touch, for an object
+    // placed at any address its alignment allows. an object is not placed
+    // at the start of a line unless it is aligned to one
+    std::size_t lines_touched(std::size_t off, std::size_t n) const noexcept {
+        if (n == 0) return 0;
+        std::size_t worst{};
+        for (std::size_t at = 0; at < cache_line_size; at += std::min(align_, cache_line_size))
+            worst = std::max(worst, (at + off + n - 1) / cache_line_size - (at + off) / cache_line_size + 1);
+        return worst;
+    }
 
-class EAssignVal : public Expression {
-    EDeclareVar dv_;
-public:
-    EAssignVal(EDeclareVar&& dv) noexcept : dv_(std::move(dv)) {}
-    ~EAssignVal() noexcept override = default;
-    ;
-};
+    std::size_t cache_lines() const noexcept {
+        return lines_touched(0, size_);
+    }
 
-class EReturn : public Expression {
-public:
-    ~EReturn() noexcept override = default;
+    // the most cache lines the span of the hot fields can touch
+    std::size_t hot_lines() const noexcept {
+        std::size_t lo = size_, hi{};
+        for (const auto& f : fields_)
+            if (f.field_.hot_) {
+                lo = std::min(lo, f.offset_);
+                hi = std::max(hi, f.offset_ + f.size_);
+            }
+        return lo < hi ? lines_touched(lo, hi - lo) : 0;
+    }
 
-    std::ostream& dump_info(std::ostream& os) const noexcept override {
-        return os;
+    bool may_split_cache_line(const FieldSlot& f) const noexcept {
+        return lines_touched(f.offset_, f.size_) > (f.size_ + cache_line_size - 1) / cache_line_size;
     }
 
-    CodeBlock gen_code() const noexcept override {
-        return CodeBlock{};
+    std::ostream& dump(std::ostream& os) const noexcept {
+        os << "*** Dumping layout: " << name_ << '\n';
+        for (const auto& b : bases_)
+            os << std::setw(6) << b.offset_ << " | base " << b.name_
+                << (b.size_ ? "" : " (empty)") << '\n';
+        for (const auto& f : fields_)
+            os << std::setw(6) << f.offset_ << " | " << f.field_.type_ << ' ' << f.field_.name_
+                << (f.field_.hot_ ? " [hot]" : "")
+                << (may_split_cache_line(f) ? " [may split cache line]" : "") << '\n';
+        os << "       | [sizeof=" << size_ << ", align=" << align_
+            << ", padding=" << padding() << ", cache lines=" << cache_lines();
+        if (const auto h = hot_lines()) os << ", hot lines=" << h;
+        os << "]\n";
+        return os;
     }
 };
 
-////
-
-#define __MK_EXC(str) std::exception{(str).c_str()}
-#define EXPECTED(t1, t2) std::unexpected(__MK_EXC("Expected " + zpp::tok::stringify_tok(t1) + ", but " + zpp::tok::stringify_tok(t2)))
+class LayoutEngine {
+    std::unordered_map<std::string, Layout> classes_;
+    bool pack_;
 
-////
+    static constexpr std::size_t align_up(std::size_t n, std::size_t a) noexcept {
+        return (n + a - 1) / a * a;
+    }
+
+    // places the slots in order from off, each into the first hole left
+    // before it that it fits, or else at the end. returns the end
+    static std::size_t place(std::vector<FieldSlot>& slots, std::size_t off) noexcept {
+        std::vector<std::pair<std::size_t, std::size_t>> holes{}; // [begin, end)
+        for (auto& s : slots) {
+            auto h = std::ranges::find_if(holes, [&](const auto& h) {
+                return align_up(h.first, s.align_) + s.size_ <= h.second;
+            });
+            if (h == holes.end()) {
+                s.offset_ = align_up(off, s.align_);
+                if (s.offset_ != off) holes.emplace_back(off, s.offset_);
+                off = s.offset_ + s.size_;
+                continue;
+            }
+            s.offset_ = align_up(h->first, s.align_);
+            const auto [b, e] = *h;
+            holes.erase(h);
+            if (s.offset_ + s.size_ != e) holes.emplace_back(s.offset_ + s.size_, e);
+            if (b != s.offset_) holes.emplace_back(b, s.offset_);
+        }
+        return off;
+    }
+public:
+    LayoutEngine(bool pack = false) noexcept : classes_{}, pack_(pack) {
+        // every class root
+        classes_.emplace("obj", Layout{ "obj", {}, {}, 1, 1 });
+    }
+
+    // (size, align) of a builtin type or of an already laid out class
+    std::optional<std::pair<std::size_t, std::size_t>> size_align_of(const std::string& ty) const noexcept {
+        static const std::unordered_map<std::string_view, std::size_t> builtins{
+            { "bool", 1 },
+            { "i8", 1 }, { "i16", 2 }, { "i32", 4 }, { "i64", 8 }, { "i128", 16 },
+            { "u8", 1 }, { "u16", 2 }, { "u32", 4 }, { "u64", 8 }, { "u128", 16 },
+            { "f32", 4 }, { "f64", 8 },
+        };
+        if (ty.starts_with('['))
+            return std::pair<std::size_t, std::size_t>{ 16, 8 }; // [ty] is a pointer and a length
+        if (auto b = builtins.find(ty); b != builtins.end())
+            return std::pair{ b->second, b->second };
+        if (auto c = classes_.find(ty); c != classes_.end())
+            return std::pair{ c->second.size_, c->second.align_ };
+        return {};
+    }
+
+    // bases are placed first in declaration order, then the fields.
+    // with packing, fields are sorted by descending alignment, which leaves no
+    // inner padding for power-of-two sized fields. only when the object takes
+    // more than a cache line do the hot fields go first, to share as few lines
+    // as they can, with smaller cold fields filling the holes they leave. that
+    // is kept only if it is no larger than the plain descending order.
+    auto lay_out(std::string&& name, const std::vector<std::string>& bases, std::vector<Field>&& fields) noexcept
+        -> std::expected<const Layout*, LayoutError> {
+        if (classes_.contains(name))
+            return std::unexpected<LayoutError>({ ErrCode::Redefinition, std::move(name) });
+
+        Layout l{ std::move(name), {}, {}, 0, 1 };
+        std::size_t off{};
+
+        for (const auto& b : bases) {
+            auto c = classes_.find(b);
+            if (c == classes_.end())
+                return std::unexpected<LayoutError>({ ErrCode::UnknownBase, b });
+
+            const auto& bl = c->second;
+            if (bl.is_empty()) {
+                l.bases_.push_back({ b, 0, 0 });
+                continue;
+            }
+            off = align_up(off, bl.align_);
+            l.bases_.push_back({ b, off, bl.size_ });
+            off += bl.size_;
+            l.align_ = std::max(l.align_, bl.align_);
+        }
+
+        std::vector<FieldSlot> slots{};
+        for (auto&& f : fields) {
+            auto sa = size_align_of(f.type_);
+            if (!sa)
+                return std::unexpected<LayoutError>({ ErrCode::UnknownType, std::move(f.type_) });
+            slots.push_back({ std::move(f), 0, sa->first, sa->second });
+        }
+
+        for (const auto& s : slots)
+            l.align_ = std::max(l.align_, s.align_);
+
+        if (pack_) {
+            auto by_align = [](const FieldSlot& a, const FieldSlot& b) {
+                if (a.align_ != b.align_) return a.align_ > b.align_;
+                return a.size_ > b.size_;
+            };
+            std::ranges::stable_sort(slots, by_align);
+
+            auto hot = slots;
+            std::ranges::stable_partition(hot, [](const FieldSlot& s) { return s.field_.hot_; });
+            const auto plain_end = place(slots, off);
+            if (align_up(plain_end, l.align_) > cache_line_size
+                && std::ranges::any_of(hot, [](const FieldSlot& s) { return s.field_.hot_; })) {
+                const auto hot_end = place(hot, off);
+                if (align_up(hot_end, l.align_) <= align_up(plain_end, l.align_)) {
+                    slots = std::move(hot);
+                    off = hot_end;
+                }
+                else off = plain_end;
+            }
+            else off = plain_end;
+            std::ranges::stable_sort(slots, {}, &FieldSlot::offset_);
+        }
+        else
+            for (auto& s : slots) {
+                s.offset_ = align_up(off, s.align_);
+                off = s.offset_ + s.size_;
+            }
+        l.fields_ = std::move(slots);
+        l.size_ = std::max<std::size_t>(align_up(off, l.align_), 1);
+
+        auto it = classes_.emplace(l.name_, std::move(l)).first;
+        return &it->second;
+    }
+};
+} // ns layout
+
+class Class : public AST {
+public:
+    const layout::Layout layout_;
+    Class(const layout::Layout& l) noexcept : AST{}, layout_(l) {}
+    ~Class() noexcept override = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        return layout_.dump(os);
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        return CodeBlock{};
+    }
+};
+
+class Expression : public AST {
+public:
+    virtual ~Expression() noexcept = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override = 0;
+
+    CodeBlock gen_code() const noexcept override = 0;
+
+    // code storing the value of the expression into dst
+    virtual CodeBlock lower_into(const std::string& dst) const noexcept {
+        return CodeBlock{};
+    }
+};
+
+// a literal or a variable
+class EValue : public Expression {
+    const std::string val_;
+public:
+    EValue(std::string&& val) noexcept : val_(std::move(val)) {}
+    ~EValue() noexcept override = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        return os << val_;
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        return CodeBlock{};
+    }
+
+    CodeBlock lower_into(const std::string& dst) const noexcept override {
+        CodeBlock cb{};
+        cb.emit({ CodeBlock::Op::Set, dst, val_ });
+        return cb;
+    }
+};
+
+// src | transform(..) | filter(..) | take(n) | join [| reduce(op)]
+class ERangePipeline : public Expression {
+public:
+    struct Stage {
+        enum class Kind {
+            Transform,
+            Filter,
+            Take,
+            Join,
+            Reduce
+        } kind_;
+
+        std::string fn_; // transform(fn), filter(fn)
+        std::string op_; // transform(_ op imm), filter(_ op imm), reduce(op)
+        std::int64_t imm_; // also take(imm)
+    };
+
+    const std::string src_;
+    const std::string src_ty_;
+    std::vector<Stage> stages_;
+
+    ERangePipeline(const std::string& src, const std::string& src_ty) noexcept
+        : src_(src), src_ty_(src_ty), stages_{} {}
+    ~ERangePipeline() noexcept override = default;
+
+    // [ty] -> ty, or empty if ty is not a range
+    static std::string elem_ty_of(std::string_view ty) noexcept {
+        if (ty.size() < 2 || !ty.starts_with('[') || !ty.ends_with(']')) return {};
+        return std::string{ ty.substr(1, ty.size() - 2) };
+    }
+
+    // starting value of reduce(op) over ty
+    static std::string identity_of(std::string_view op, std::string_view ty) noexcept {
+        if (op == "*") return "1";
+        if (op == "&") return "-1";
+        if (op == "min" || op == "max") {
+            const auto bits = ty == "i8" ? 8 : ty == "i16" ? 16 : ty == "i32" ? 32 : 64;
+            const auto lim = std::uint64_t{ 1 } << (bits - 1);
+            return op == "min" ? std::to_string(lim - 1) : '-' + std::to_string(lim);
+        }
+        return "0";
+    }
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        os << src_;
+        for (const auto& s : stages_) {
+            switch (s.kind_) {
+            case Stage::Kind::Transform:
+                os << " | transform(";
+                break;
+            case Stage::Kind::Filter:
+                os << " | filter(";
+                break;
+            case Stage::Kind::Take:
+                os << " | take(" << s.imm_ << ')';
+                continue;
+            case Stage::Kind::Join:
+                os << " | join";
+                continue;
+            case Stage::Kind::Reduce:
+                os << " | reduce(" << s.op_ << ')';
+                continue;
+            }
+            if (s.fn_.empty()) os << "_ " << s.op_ << ' ' << s.imm_ << ')';
+            else os << s.fn_ << ')';
+        }
+        return os;
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        return CodeBlock{};
+    }
+
+    // every stage is fused into one loop nest over src_, with no
+    // intermediate range in between. join opens a nested loop over
+    // the current element, and the nest is closed once at the end.
+    // a reduce folds into dst in place of the yield.
+    CodeBlock lower_into(const std::string& dst) const noexcept override {
+        using Op = CodeBlock::Op;
+
+        CodeBlock cb{};
+        auto ty = elem_ty_of(src_ty_);
+        std::size_t loops = 1;
+        const Stage* reduce = !stages_.empty() && stages_.back().kind_ == Stage::Kind::Reduce
+            ? &stages_.back() : nullptr;
+
+        if (reduce) {
+            auto elem_ty = ty;
+            for (const auto& s : stages_)
+                if (s.kind_ == Stage::Kind::Join) elem_ty = elem_ty_of(elem_ty);
+            cb.emit({ Op::Set, dst, identity_of(reduce->op_, elem_ty) });
+        }
+
+        cb.emit({ Op::LoopBegin, src_, {}, 0, ty });
+        for (const auto& s : stages_) {
+            switch (s.kind_) {
+            case Stage::Kind::Transform:
+                cb.emit({ Op::Map, s.fn_, s.op_, s.imm_, ty });
+                break;
+            case Stage::Kind::Filter:
+                cb.emit({ Op::Guard, s.fn_, s.op_, s.imm_, ty });
+                break;
+            case Stage::Kind::Take:
+                cb.emit({ Op::Take, {}, {}, s.imm_, ty });
+                break;
+            case Stage::Kind::Join:
+                ty = elem_ty_of(ty);
+                cb.emit({ Op::LoopBegin, "_", {}, 0, ty });
+                ++loops;
+                break;
+            case Stage::Kind::Reduce:
+                break;
+            }
+        }
+        if (reduce) cb.emit({ Op::Reduce, dst, reduce->op_, 0, ty });
+        else cb.emit({ Op::Yield, dst, {}, 0, ty });
+        while (loops--)
+            cb.emit({ Op::LoopEnd });
+        return cb;
+    }
+};
+
+class EAssignVal;
+
+class EDeclareVar : public Expression {
+    const std::string name_;
+    const std::string type_;
+    std::unique_ptr<Expression> val_;
+public:
+    EDeclareVar(EDeclareVar&& dv) noexcept
+        : name_(dv.name_), type_(dv.type_), val_(std::move(dv.val_)) {}
+    EDeclareVar(std::string&& name, std::string&& type, std::unique_ptr<Expression> val = nullptr) noexcept
+        : name_(std::move(name)), type_(std::move(type)), val_(std::move(val)) {}
+    ~EDeclareVar() noexcept override = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        return os;
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        return val_ ? val_->lower_into(name_) : CodeBlock{};
+    }
+
+    friend EAssignVal;
+};
+
+class EAssignVal : public Expression {
+    EDeclareVar dv_;
+public:
+    EAssignVal(EDeclareVar&& dv) noexcept : dv_(std::move(dv)) {}
+    ~EAssignVal() noexcept override = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        return os;
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        return dv_.gen_code();
+    }
+};
+
+class EReturn : public Expression {
+    std::unique_ptr<Expression> val_;
+public:
+    EReturn(std::unique_ptr<Expression> val = nullptr) noexcept : val_(std::move(val)) {}
+    ~EReturn() noexcept override = default;
+
+    std::ostream& dump_info(std::ostream& os) const noexcept override {
+        return os;
+    }
+
+    CodeBlock gen_code() const noexcept override {
+        CodeBlock cb{};
+        if (val_) cb.append(val_->lower_into("ret"));
+        cb.emit({ CodeBlock::Op::Ret, val_ ? "ret" : "" });
+        return cb;
+    }
+};
+
+namespace vec {
+namespace details {
+using Op = CodeBlock::Op;
+
+// a countable loop over a named i8..i64 range whose body only maps, filters
+// and folds the element with immediates. the only state carried from one
+// element to the next is the reduction. returns the index of its LoopEnd.
+auto vectorizable(const std::vector<CodeBlock::Instr>& is, std::size_t b) noexcept
+    -> std::optional<std::size_t> {
+    const auto& head = is[b];
+    if (head.op_ != Op::LoopBegin || head.imm_ || head.sym_ == "_" || !simd::int_width(head.ty_))
+        return {};
+
+    bool guarded{};
+    for (auto e = b + 1; e < is.size(); ++e) {
+        const auto& i = is[e];
+        const auto op = simd::binop_of(i.arg_);
+        switch (i.op_) {
+        case Op::LoopEnd:
+            return e;
+        case Op::Map:
+            // no vector division
+            if (!i.sym_.empty() || op == simd::BinOp::Bad || op == simd::BinOp::Div || op == simd::BinOp::Mod
+                || !simd::fits(i.imm_, head.ty_))
+                return {};
+            break;
+        case Op::Guard:
+            if (!i.sym_.empty() || op == simd::BinOp::Bad || op == simd::BinOp::Div
+                || !simd::fits(i.imm_, head.ty_))
+                return {};
+            if (op == simd::BinOp::Mod && (i.imm_ <= 0 || (i.imm_ & (i.imm_ - 1))))
+                return {};
+            guarded = true;
+            break;
+        case Op::Reduce:
+            break;
+        case Op::Yield:
+            // yielding filtered elements would need compaction,
+            // and yielding into the source would overwrite it
+            if (guarded || i.sym_ == head.sym_)
+                return {};
+            break;
+        default:
+            // take leaves early, and nested loops come from join
+            return {};
+        }
+    }
+    return {};
+}
+} // ns details
+
+// every vectorizable loop is split into a VecLoopBegin loop, taking as many
+// elements as fit an avx2 register at once, and the scalar loop over the rest
+void vectorize(CodeBlock& cb) noexcept {
+    using Op = CodeBlock::Op;
+
+    std::vector<CodeBlock::Instr> out{};
+    const auto& is = cb.insts_;
+    for (std::size_t b = 0; b < is.size(); ++b) {
+        auto e = details::vectorizable(is, b);
+        if (!e) {
+            out.push_back(is[b]);
+            continue;
+        }
+
+        const auto& head = is[b];
+        const auto lanes = static_cast<std::int64_t>(32 / simd::int_width(head.ty_));
+        std::vector<CodeBlock::Instr> body{ is.begin() + b + 1, is.begin() + *e };
+        // (x % 2^k) != 0 is (x & 2^k - 1) != 0, and there is no vector division
+        for (auto& i : body)
+            if (i.op_ == Op::Guard && simd::binop_of(i.arg_) == simd::BinOp::Mod) {
+                i.arg_ = "&";
+                i.imm_ -= 1;
+            }
+
+        out.push_back({ Op::VecLoopBegin, head.sym_, {}, lanes, head.ty_ });
+        out.insert(out.end(), body.begin(), body.end());
+        out.push_back({ Op::LoopEnd });
+        out.push_back({ Op::LoopBegin, head.sym_, {}, lanes, head.ty_ });
+        out.insert(out.end(), body.begin(), body.end());
+        out.push_back({ Op::LoopEnd });
+        b = *e;
+    }
+    cb.insts_ = std::move(out);
+}
+} // ns vec
+
+// runs lowered code over integer ranges
+namespace exec {
+using Value = std::variant<std::int64_t,
+    std::vector<std::int8_t>, std::vector<std::int16_t>, std::vector<std::int32_t>, std::vector<std::int64_t>>;
+using Env = std::unordered_map<std::string, Value>;
+
+namespace details {
+using Op = CodeBlock::Op;
+
+// calls f with a value of the integer type named ty
+template <typename F>
+bool with_int_ty(std::string_view ty, F&& f) {
+    if (ty == "i8") f(std::int8_t{});
+    else if (ty == "i16") f(std::int16_t{});
+    else if (ty == "i32") f(std::int32_t{});
+    else if (ty == "i64") f(std::int64_t{});
+    else return false;
+    return true;
+}
+
+template <typename T>
+auto run_loop(const CodeBlock::Instr& head, std::span<const CodeBlock::Instr> body, Env& env) noexcept
+    -> std::expected<void, std::exception> {
+    auto v = env.find(head.sym_);
+    auto* src = v != env.end() ? std::get_if<std::vector<T>>(&v->second) : nullptr;
+    if (!src)
+        return std::unexpected<std::exception>(("'" + head.sym_ + "' is not a [" + head.ty_ + ']').c_str());
+
+    // a vector loop stops at the last full vector, and its remainder loop
+    // picks up from there
+    const bool is_vec = head.op_ == Op::VecLoopBegin;
+    const bool is_rest = head.op_ == Op::LoopBegin && head.imm_;
+    const auto n = src->size();
+    const auto begin = is_rest ? n / head.imm_ * head.imm_ : 0;
+    const auto end = is_vec ? n / head.imm_ * head.imm_ : n;
+
+    struct Step {
+        Op op_;
+        simd::BinOp bop_;
+        T imm_;
+        std::int64_t limit_; // take
+        std::size_t slot_; // into outs or accs
+    };
+    std::vector<Step> steps{};
+    std::vector<std::pair<std::string, std::vector<T>>> outs{};
+    std::vector<std::pair<std::string, T>> accs{};
+
+    for (const auto& i : body) {
+        Step s{ i.op_, simd::binop_of(i.arg_), static_cast<T>(i.imm_), i.imm_, 0 };
+        switch (i.op_) {
+        case Op::Map:
+        case Op::Guard:
+            if (!i.sym_.empty())
+                return std::unexpected<std::exception>("Calls are not supported by the interpreter");
+            if (s.bop_ == simd::BinOp::Bad)
+                return std::unexpected<std::exception>(("Unknown operator '" + i.arg_ + '\'').c_str());
+            if (!simd::fits(i.imm_, head.ty_))
+                return std::unexpected<std::exception>(
+                    (std::to_string(i.imm_) + " does not fit in " + head.ty_).c_str());
+            break;
+        case Op::Take:
+            break;
+        case Op::Yield:
+            s.slot_ = outs.size();
+            outs.emplace_back(i.sym_, std::vector<T>{});
+            break;
+        case Op::Reduce: {
+            auto a = env.find(i.sym_);
+            auto* init = a != env.end() ? std::get_if<std::int64_t>(&a->second) : nullptr;
+            if (!init || s.bop_ == simd::BinOp::Bad)
+                return std::unexpected<std::exception>(("Bad reduction into '" + i.sym_ + '\'').c_str());
+            s.slot_ = accs.size();
+            accs.emplace_back(i.sym_, static_cast<T>(*init));
+            break;
+        }
+        default:
+            return std::unexpected<std::exception>("Nested loops are not supported by the interpreter");
+        }
+        steps.push_back(s);
+    }
+
+    if (is_vec) {
+        // a block of elements goes through every step at once,
+        // so each step is one simd kernel call
+        constexpr std::size_t block = 256;
+        alignas(32) T buf[block];
+        alignas(32) T mask[block];
+        const bool guarded = std::ranges::any_of(steps, [](const auto& s) { return s.op_ == Op::Guard; });
+
+        for (auto base = begin; base < end; base += block) {
+            const auto m = std::min(block, end - base);
+            std::copy_n(src->data() + base, m, buf);
+            if (guarded) std::fill_n(mask, m, static_cast<T>(-1));
+
+            for (const auto& s : steps) {
+                switch (s.op_) {
+                case Op::Map:
+                    simd::map(buf, m, s.bop_, s.imm_);
+                    break;
+                case Op::Guard:
+                    simd::guard(buf, mask, m, s.bop_, s.imm_);
+                    break;
+                case Op::Reduce: {
+                    auto& acc = accs[s.slot_].second;
+                    acc = simd::apply(acc, s.bop_, simd::reduce(buf, guarded ? mask : nullptr, m, s.bop_));
+                    break;
+                }
+                case Op::Yield:
+                    outs[s.slot_].second.insert(outs[s.slot_].second.end(), buf, buf + m);
+                    break;
+                default:
+                    ;
+                }
+            }
+        }
+    }
+    else {
+        std::vector<std::int64_t> taken(steps.size());
+        for (auto idx = begin; idx < end; ++idx) {
+            T x = (*src)[idx];
+            for (std::size_t k = 0; k < steps.size(); ++k) {
+                const auto& s = steps[k];
+                switch (s.op_) {
+                case Op::Map:
+                    x = simd::apply(x, s.bop_, s.imm_);
+                    continue;
+                case Op::Guard:
+                    if (simd::apply(x, s.bop_, s.imm_) != 0) continue;
+                    goto NEXT_ELEM;
+                case Op::Take:
+                    if (++taken[k] <= s.limit_) continue;
+                    goto LOOP_DONE;
+                case Op::Yield:
+                    outs[s.slot_].second.push_back(x);
+                    continue;
+                case Op::Reduce: {
+                    auto& acc = accs[s.slot_].second;
+                    acc = simd::apply(acc, s.bop_, x);
+                    continue;
+                }
+                default:
+                    ;
+                }
+            }
+        NEXT_ELEM:
+            ;
+        }
+    LOOP_DONE:
+        ;
+    }
+
+    for (auto& [sym, acc] : accs)
+        env[sym] = static_cast<std::int64_t>(acc);
+    for (auto& [sym, out] : outs) {
+        // the remainder appends to what its vector loop yielded
+        if (auto* prev = is_rest && env.contains(sym) ? std::get_if<std::vector<T>>(&env[sym]) : nullptr)
+            prev->insert(prev->end(), out.begin(), out.end());
+        else
+            env[sym] = std::move(out);
+    }
+    return {};
+}
+} // ns details
+
+auto run(const CodeBlock& cb, Env& env) noexcept -> std::expected<Value, std::exception> {
+    using Op = CodeBlock::Op;
+
+    const auto& is = cb.insts_;
+    for (std::size_t b = 0; b < is.size(); ++b) {
+        const auto& i = is[b];
+        switch (i.op_) {
+        case Op::Set: {
+            std::int64_t imm{};
+            if (auto [p, ec] = std::from_chars(i.arg_.data(), i.arg_.data() + i.arg_.size(), imm);
+                ec == std::errc{} && p == i.arg_.data() + i.arg_.size()) {
+                env[i.sym_] = imm;
+                break;
+            }
+            auto v = env.find(i.arg_);
+            if (v == env.end())
+                return std::unexpected<std::exception>(("Unknown value '" + i.arg_ + '\'').c_str());
+            Value val = v->second;
+            env[i.sym_] = std::move(val);
+            break;
+        }
+        case Op::Ret:
+            return i.sym_.empty() ? Value{} : env[i.sym_];
+        case Op::LoopBegin:
+        case Op::VecLoopBegin: {
+            auto e = b + 1;
+            while (e < is.size() && is[e].op_ != Op::LoopEnd) ++e;
+
+            std::expected<void, std::exception> r =
+                std::unexpected<std::exception>(("Unsupported element type '" + i.ty_ + '\'').c_str());
+            details::with_int_ty(i.ty_, [&]<typename T>(T) {
+                r = details::run_loop<T>(i, { is.begin() + b + 1, is.begin() + e }, env);
+            });
+            if (!r) return std::unexpected(r.error());
+            b = e;
+            break;
+        }
+        default:
+            return std::unexpected<std::exception>("Unexpected instruction");
+        }
+    }
+    return Value{};
+}
+} // ns exec
+
+////
+
+#define __MK_EXC(str) std::exception{(str).c_str()}
+#define EXPECTED(t1, t2) std::unexpected(__MK_EXC("Expected " + zpp::tok::stringify_tok(t1) + ", but " + zpp::tok::stringify_tok(t2)))
+
+////
 
 template <typename E>
 class LookUp {
@@ -420,6 +1961,16 @@ public:
         return *i_;
     }
 
+    // index of the next token to look at
+    std::size_t pos() const noexcept {
+        return static_cast<std::size_t>(i_ - r_.begin());
+    }
+
+    // moves back or forth to the token at p
+    void seek(std::size_t p) noexcept {
+        i_ = r_.begin() + static_cast<std::ptrdiff_t>(std::min(p, r_.size()));
+    }
+
     E drop() noexcept {
         return *i_++;
     }
@@ -429,45 +1980,130 @@ public:
     }
 };
 
-typedef struct {
-    struct {
-        std::size_t row_;
-        std::size_t col_;
-    } pos_;
+// error arguments are kept once per thread, and referred to by index
+class Symbols {
+    std::deque<std::string> strs_; // never moves its elements
+    std::unordered_map<std::string_view, std::uint32_t> ids_;
+public:
+    std::uint32_t intern(std::string_view s) noexcept {
+        if (auto i = ids_.find(s); i != ids_.end())
+            return i->second;
+        const auto id = static_cast<std::uint32_t>(strs_.size());
+        ids_.emplace(strs_.emplace_back(s), id);
+        return id;
+    }
 
-    std::string err_desc_;
-} Error;
+    std::string_view str(std::uint32_t id) const noexcept {
+        return strs_[id];
+    }
 
+    static Symbols& local() noexcept {
+        thread_local Symbols syms{};
+        return syms;
+    }
+};
+
+// an error as recorded, formatted only once emitted
+struct Error {
+    std::uint32_t tok_; // index of the next token when the error was found
+    ErrCode code_;
+    std::array<std::uint32_t, 2> args_; // interned symbols, or tokens tagged with tok_arg
+};
+
+// errors are recorded into, and emitted from, the thread parsing fpath_
 class ErrorLog {
     std::ostream& os_;
     std::filesystem::path fpath_;
+    init::compile_env::DiagFormat format_;
     std::vector<Error> err_;
+
+    static constexpr std::uint32_t tok_arg = 1u << 31;
+
+    static std::uint32_t arg(tok::Token t) noexcept {
+        return tok_arg | static_cast<std::uint32_t>(t);
+    }
+
+    static std::uint32_t arg(std::string_view s) noexcept {
+        return Symbols::local().intern(s);
+    }
+
+    static std::string arg_str(std::uint32_t a) noexcept {
+        if (a & tok_arg)
+            return tok::stringify_tok(static_cast<tok::Token>(a & ~tok_arg));
+        return std::string{ Symbols::local().str(a) };
+    }
+
+    static std::string json_quote(std::string_view s) noexcept {
+        std::string ret{ '"' };
+        for (const char c : s) {
+            switch (c) {
+            case '"': ret += "\\\""; break;
+            case '\\': ret += "\\\\"; break;
+            case '\n': ret += "\\n"; break;
+            case '\t': ret += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    constexpr char hex[] = "0123456789abcdef";
+                    ret += "\\u00";
+                    ret += hex[c >> 4];
+                    ret += hex[c & 0xf];
+                }
+                else ret += c;
+            }
+        }
+        return ret += '"';
+    }
+
+    // the message with its arguments filled in, and the arguments used
+    static auto format(const Error& e) noexcept -> std::pair<std::string, std::vector<std::string>> {
+        std::string msg{};
+        std::vector<std::string> args{};
+        std::string_view fmt = err_infos[static_cast<std::size_t>(e.code_)].second;
+        for (std::size_t at; (at = fmt.find("{}")) != fmt.npos; fmt.remove_prefix(at + 2)) {
+            msg += fmt.substr(0, at);
+            msg += args.emplace_back(arg_str(e.args_[args.size()]));
+        }
+        msg += fmt;
+        return { std::move(msg), std::move(args) };
+    }
 public:
     template <typename Path>
-    ErrorLog(Path&& p, std::ostream& os) noexcept : os_(os), fpath_{ std::forward<Path>(p) } {}
+    ErrorLog(Path&& p, std::ostream& os,
+        init::compile_env::DiagFormat format = init::compile_env::DiagFormat::Text) noexcept
+        : os_(os), fpath_{ std::forward<Path>(p) }, format_(format), err_{} {}
+
+    // a later error at the same token is a consequence of the first, and is dropped
+    template <typename... Args>
+        requires (sizeof...(Args) <= 2)
+    void add_error(ErrCode c, std::size_t tok, Args&&... args) noexcept {
+        if (!err_.empty() && err_.back().tok_ == tok) return;
+        err_.push_back({ static_cast<std::uint32_t>(tok), c, { arg(std::forward<Args>(args))... } });
+    }
 
-    void add_error(Error&& e) noexcept {
-        err_.push_back(std::move(e));
+    bool empty() const noexcept {
+        return err_.empty();
     }
 
-    template <typename Ret>
-    auto submit_and_exit(int code = 0) noexcept -> Ret
-    {
-        auto logify = [this]<typename T>(T&& _e) -> std::string
-        {
-            Error e = std::forward<T>(_e);
-            std::stringstream ss;
-            ss << fpath_.string() << '(' << e.pos_.col_ << ", " << e.pos_.row_ << "): error: "
-                << e.err_desc_;
-            return ss.str();
-        };
-        auto v =
-            err_
-            | std::views::transform(logify)
-            | std::views::join_with(std::string{ '\n' });
-        std::ranges::for_each(v, [this](auto&& s) { os_ << s; });
-        std::exit(code);
-        return *static_cast<Ret*>(nullptr);
+    std::size_t size() const noexcept {
+        return err_.size();
+    }
+
+    void emit() noexcept {
+        const auto file = fpath_.string();
+        for (const auto& e : err_) {
+            auto [msg, args] = format(e);
+            if (format_ == init::compile_env::DiagFormat::Json) {
+                os_ << "{\"file\":" << json_quote(file) << ",\"token\":" << e.tok_
+                    << ",\"code\":" << json_quote(stringify_err(e.code_))
+                    << ",\"message\":" << json_quote(msg) << ",\"args\":[";
+                for (std::size_t i = 0; i < args.size(); ++i)
+                    os_ << (i ? "," : "") << json_quote(args[i]);
+                os_ << "]}\n";
+            }
+            else
+                os_ << file << "(token " << e.tok_ << "): error: " << msg << '\n';
+        }
+        err_.clear();
     }
 };
 
@@ -477,36 +2113,62 @@ auto make_codeblocks(init::compile_env&& env, auto&& tokens) noexcept
     using ve_t = std::pair<Token, std::string>;
 
     LookUp<ve_t> lookUp{ std::forward<decltype(tokens)>(tokens) };
-    ErrorLog el{ env.source_path_, std::cerr };
+    ErrorLog el{ env.source_path_, std::cerr, env.diag_format_ };
 
     // reference value type not allowed, so alternatively using pointer type
     auto _expect = [&lookUp](ErrorLog& _el, Token e = Token::Unknown) noexcept
         -> std::optional<LookUp<ve_t>*/*no-ref*/> {
         ;
-        if (e == Token::Unknown) {
-            if (lookUp.empty()) {
-                _el.add_error({ {}, "No more token" });
-                return {};
-            }
-            return &lookUp;
+        if (lookUp.empty()) {
+            _el.add_error(ErrCode::NoMoreToken, lookUp.pos());
+            return {};
         }
+        if (e == Token::Unknown)
+            return &lookUp;
         if (auto l = lookUp.look(); l && l->first != e) {
-            _el.add_error({ {}, "Expected " + stringify_tok(e) + ", but " + stringify_tok(l->first) });
+            _el.add_error(ErrCode::ExpectedToken, lookUp.pos(), e, l->first);
             return {};
         }
         return &lookUp;
     };
-    auto look = [&lookUp, &el] {
+    // errors before the declaration being parsed
+    std::size_t decl_errs{};
+
+    // once the declaration has an error nothing more is consumed, and Eof
+    // stands in for every token, so it bails out
+    auto look = [&lookUp, &el, &decl_errs]() noexcept
+        -> ve_t {
         auto l = lookUp.look();
-        return l.has_value() ? *l : el.submit_and_exit<ve_t>();
+        return l.has_value() && el.size() == decl_errs ? *l : ve_t{ Token::Eof, {} };
     };
-    auto eat = [&_expect, &el](Token e = Token::Unknown) noexcept
+    auto eat = [&_expect, &el, &decl_errs](Token e = Token::Unknown) noexcept
         -> ve_t {
+        if (el.size() != decl_errs) return { Token::Eof, {} };
         auto v = _expect(el, e);
-        return v.has_value() ? v.value()->drop() : el.submit_and_exit<ve_t>();
+        return v.has_value() ? v.value()->drop() : ve_t{ Token::Eof, {} };
+    };
+    auto peek_is = [&lookUp](Token t, std::string_view w) noexcept {
+        auto l = lookUp.look();
+        return l && l->first == t && l->second == w;
+    };
+
+    auto expect_type = [&]() noexcept
+    -> ve_t {
+        // ty | [ty]
+        std::size_t dims{};
+        while (peek_is(Token::Bracket, "[")) {
+            eat();
+            ++dims;
+        }
+        auto t = eat(Token::Identifier);
+        for (auto d = dims; d--;)
+            if (eat(Token::Bracket).second != "]")
+                el.add_error(ErrCode::Expected, lookUp.pos(), "]");
+        t.second = std::string(dims, '[') + t.second + std::string(dims, ']');
+        return t;
     };
 
-    auto expect_fargs = [&eat, &el](auto& buf) noexcept
+    auto expect_fargs = [&lookUp, &eat, &el, &expect_type](auto& buf) noexcept
         -> std::vector<std::pair<std::string, std::string>> {
         // func ( arg : ty , ... )
         // 1~^ 2^ 3~^ 4 5^ 6 7~^ 8
@@ -518,7 +2180,7 @@ auto make_codeblocks(init::compile_env&& env, auto&& tokens) noexcept
         buf = eat();
         if (buf.first == Token::Paren) {
             if (buf.second == ")") {
-                el.add_error({ {},  "Expected '('" });
+                el.add_error(ErrCode::Expected, lookUp.pos(), "(");
                 return {};
             }
         }
@@ -526,7 +2188,7 @@ auto make_codeblocks(init::compile_env&& env, auto&& tokens) noexcept
         buf = eat();
         if (buf.first == Token::Paren) { // 8
             if (buf.second == "(")
-                el.add_error({{}, "Expected ')'"});
+                el.add_error(ErrCode::Expected, lookUp.pos(), ")");
             return {}; // non-argument function
         }
         // 7
@@ -535,8 +2197,7 @@ PARSE_FARG:
         // 3
         if (buf.first != Token::Identifier)
         {
-            el.add_error({ {},
-                "Expected " + stringify_tok(Token::Identifier) + ", but " + stringify_tok(buf.first) });
+            el.add_error(ErrCode::ExpectedToken, lookUp.pos(), Token::Identifier, buf.first);
             return {};
         }
         pbuf.first = std::move(buf.second);
@@ -545,7 +2206,7 @@ PARSE_FARG:
         buf = eat(Token::TypeOf);
 
         // 5
-        buf = eat(Token::Identifier);
+        buf = expect_type();
         pbuf.second = std::move(buf.second);
         ret.push_back(std::move(pbuf));
 
@@ -559,35 +2220,189 @@ PARSE_FARG:
 
         if (buf.first == Token::Paren) {
             if (buf.second == "(") {
-                el.add_error({ {}, "Expected ')'" });
+                el.add_error(ErrCode::Expected, lookUp.pos(), ")");
                 return {};
             }
             return ret;
         }
-        el.add_error({ {}, "Unexpected " + stringify_tok(buf.first) + ", expected ')'" });
+        el.add_error(ErrCode::UnexpectedToken, lookUp.pos(), buf.first, ")");
         return {};
     };
 
-    auto expect_type = [&]() noexcept
-    -> ve_t {
-        return eat(Token::Identifier);
+    auto expect_imm = [&]() noexcept
+        -> std::optional<std::int64_t> {
+        // - lexes as an operator, so a negative immediate is two tokens
+        const bool neg = peek_is(Token::Operator, "-");
+        if (neg) eat();
+        auto l = (neg ? "-" : "") + eat(Token::Literal).second;
+        std::int64_t imm{};
+        if (auto [p, ec] = std::from_chars(l.data(), l.data() + l.size(), imm);
+            ec != std::errc{} || p != l.data() + l.size()) {
+            el.add_error(ErrCode::ExpectedInteger, lookUp.pos(), l);
+            return {};
+        }
+        return imm;
     };
 
-    auto glob_ns = code::Namespace {};
+    // [views::] transform(_ op imm | fn) | filter(_ op imm | fn) | take(imm) | join | reduce(op)
+    // ty is the element type flowing into the stage, and is updated by join
+    auto expect_stage = [&](std::string& ty) noexcept
+        -> std::optional<ERangePipeline::Stage> {
+        using Kind = ERangePipeline::Stage::Kind;
 
-    // namespace or class or function
-    auto buf = look(); //  eat(Token::Identifier);
+        auto b = eat(Token::Identifier);
+        if (b.second == "views" && peek_is(Token::Separator, "::")) {
+            eat();
+            b = eat(Token::Identifier);
+        }
 
-    while (buf.first == Token::Identifier) {
-        eat();
+        ERangePipeline::Stage s{ Kind::Join, {}, {}, 0 };
+        if (b.second == "join") {
+            if (peek_is(Token::Paren, "(")) {
+                eat();
+                if (eat(Token::Paren).second != ")")
+                    el.add_error(ErrCode::Expected, lookUp.pos(), ")");
+            }
+            ty = ERangePipeline::elem_ty_of(ty);
+            if (ty.empty()) {
+                el.add_error(ErrCode::JoinNonRange, lookUp.pos());
+                return {};
+            }
+            return s;
+        }
+        if (b.second == "transform") s.kind_ = Kind::Transform;
+        else if (b.second == "filter") s.kind_ = Kind::Filter;
+        else if (b.second == "take") s.kind_ = Kind::Take;
+        else if (b.second == "reduce") s.kind_ = Kind::Reduce;
+        else {
+            el.add_error(ErrCode::UnknownAdaptor, lookUp.pos(), b.second);
+            return {};
+        }
+
+        if (eat(Token::Paren).second != "(") {
+            el.add_error(ErrCode::Expected, lookUp.pos(), "(");
+            return {};
+        }
+        // only functions take elements other than integers
+        auto int_elems = [&]() noexcept {
+            if (simd::int_width(ty)) return true;
+            el.add_error(ErrCode::NotAnInteger, lookUp.pos(), b.second, ty);
+            return false;
+        };
+        if (s.kind_ == Kind::Take) {
+            auto n = expect_imm();
+            if (!n) return {};
+            if (*n < 0) {
+                el.add_error(ErrCode::NegativeTake, lookUp.pos(), std::to_string(*n));
+                return {};
+            }
+            s.imm_ = *n;
+        }
+        else if (s.kind_ == Kind::Reduce) {
+            if (!int_elems()) return {};
+            s.op_ = eat().second;
+            constexpr std::string_view ops[]{ "+", "*", "&", "|", "^", "min", "max" };
+            if (std::ranges::find(ops, s.op_) == std::end(ops)) {
+                el.add_error(ErrCode::UnknownReduction, lookUp.pos(), s.op_);
+                return {};
+            }
+        }
+        else if (auto a = eat(Token::Identifier); a.second == "_") {
+            if (!int_elems()) return {};
+            s.op_ = eat(Token::Operator).second;
+            auto n = expect_imm();
+            if (!n) return {};
+            if ((s.op_ == "/" || s.op_ == "%") && *n == 0) {
+                el.add_error(ErrCode::DivisionByZero, lookUp.pos());
+                return {};
+            }
+            if (!simd::fits(*n, ty)) {
+                el.add_error(ErrCode::ImmOutOfRange, lookUp.pos(), std::to_string(*n), ty);
+                return {};
+            }
+            s.imm_ = *n;
+        }
+        else s.fn_ = std::move(a.second);
+
+        if (eat(Token::Paren).second != ")") {
+            el.add_error(ErrCode::Expected, lookUp.pos(), ")");
+            return {};
+        }
+        return s;
+    };
+
+    // value ( '|' stage )*
+    auto expect_expr = [&](const std::unordered_map<std::string, std::string>& vars) noexcept
+        -> std::unique_ptr<Expression> {
+        auto v = eat();
+        if (v.first != Token::Literal && v.first != Token::Identifier) {
+            el.add_error(ErrCode::ExpectedValue, lookUp.pos(), v.first);
+            return nullptr;
+        }
+        if (!peek_is(Token::Operator, "|"))
+            return std::make_unique<EValue>(std::move(v.second));
+
+        auto ty = v.first == Token::Identifier && vars.contains(v.second) ? vars.at(v.second) : std::string{};
+        auto elem_ty = ERangePipeline::elem_ty_of(ty);
+        if (elem_ty.empty()) {
+            el.add_error(ErrCode::NotARange, lookUp.pos(), v.second);
+            return nullptr;
+        }
+
+        auto p = std::make_unique<ERangePipeline>(v.second, ty);
+        while (peek_is(Token::Operator, "|")) {
+            eat();
+            if (!p->stages_.empty() && p->stages_.back().kind_ == ERangePipeline::Stage::Kind::Reduce) {
+                el.add_error(ErrCode::ReduceNotLast, lookUp.pos());
+                return nullptr;
+            }
+            auto s = expect_stage(elem_ty);
+            if (!s) return nullptr;
+            p->stages_.push_back(std::move(*s));
+        }
+        return p;
+    };
+
+    // skips the declaration starting at the token decl, up to the } closing
+    // its first {, or to the end when it has none
+    auto skip_decl = [&lookUp](std::size_t decl) noexcept {
+        lookUp.seek(decl);
+        std::size_t depth{};
+        while (!lookUp.empty()) {
+            const auto t = lookUp.drop();
+            if (t.first != Token::Bracket) continue;
+            if (t.second == "{") ++depth;
+            else if (t.second == "}" && depth && !--depth) return;
+        }
+    };
+
+    std::vector<std::unique_ptr<AST>> codes{};
+    layout::LayoutEngine layouts{ env.pack_fields_ };
+    std::size_t ns_depth{};
+
+    // namespace or class or function. a declaration that fails is skipped
+    // up to the } closing it, and parsing goes on after it
+    while (!lookUp.empty()) {
+        const auto decl = lookUp.pos();
+        decl_errs = el.size();
+        auto buf = eat();
+
+        if (buf.first == Token::Bracket && buf.second == "}" && ns_depth) {
+            --ns_depth;
+            continue;
+        }
+        if (buf.first != Token::Identifier) {
+            el.add_error(ErrCode::Unexpected, decl, buf.second);
+            continue;
+        }
 
         std::string name = buf.second;
 
         buf = look();
         if (buf.first == Token::Paren) {
             if (buf.second != "(") {
-                el.add_error({ {}, "Unexpected ')'" });
-                continue;
+                el.add_error(ErrCode::Unexpected, lookUp.pos(), ")");
+                goto DECL_DONE;
             }
             auto ve = expect_fargs(buf);
             auto args = std::move(ve);
@@ -595,71 +2410,248 @@ PARSE_FARG:
             buf = eat(Token::TypeOf);
 
             buf = expect_type();
+            if (el.size() != decl_errs) goto DECL_DONE;
 
-            Function c_func{ std::move(name), std::move(buf.second), std::move(args) };
-            c_func.dump_info(std::cerr);
+            auto c_func = std::make_unique<Function>(std::move(name), std::move(buf.second), std::move(args));
             // parse function body
 
             buf = eat(Token::Bracket);
             if (buf.second != "{")
             {
-                el.add_error({ {}, "Expected '{'" });
-                continue;
+                el.add_error(ErrCode::Expected, lookUp.pos(), "{");
+                goto DECL_DONE;
             }
 
-            // empty function
-            if (auto l = look(); l.first == Token::Bracket && l.second == "}") {
-                glob_ns.add_func(std::move(c_func));
-                continue;
+            // ret expr | var: ty [= expr] | var = expr
+            std::unordered_map<std::string, std::string> vars{ c_func->farg_.begin(), c_func->farg_.end() };
+        PARSE_STMT:
+            buf = eat();
+            if (buf.first == Token::Identifier && buf.second == "ret") {
+                auto val = expect_expr(vars);
+                if (!val) goto DECL_DONE;
+                c_func->body_.push_back(std::make_unique<EReturn>(std::move(val)));
+                goto PARSE_STMT;
             }
-            else {
-                std::cout << stringify_tok(l.first) << ": " << l.second << '\n';
-                switch (l.first) {
-                case Token::Identifier:
-                    if (l.second == "ret")
-                    {
-                        EReturn ret;
+            if (buf.first == Token::Identifier) {
+                std::string var = std::move(buf.second);
+                std::string ty{};
+                if (peek_is(Token::TypeOf, ":")) {
+                    eat();
+                    ty = expect_type().second;
+                    vars[var] = ty;
+                }
+                const bool is_decl = !ty.empty();
+
+                std::unique_ptr<Expression> val{};
+                if (!is_decl || peek_is(Token::Operator, "=")) {
+                    if (eat(Token::Operator).second != "=") {
+                        el.add_error(ErrCode::Expected, lookUp.pos(), "=");
+                        goto DECL_DONE;
                     }
-                    break;
-                default:
-                    el.add_error({ {}, "Unexpected '" + l.second + '\'' });
-                    continue;
+                    if (val = expect_expr(vars); !val) goto DECL_DONE;
                 }
+
+                EDeclareVar dv{ std::move(var), std::move(ty), std::move(val) };
+                if (is_decl)
+                    c_func->body_.push_back(std::make_unique<EDeclareVar>(std::move(dv)));
+                else
+                    c_func->body_.push_back(std::make_unique<EAssignVal>(std::move(dv)));
+                goto PARSE_STMT;
+            }
+            if (buf.first != Token::Bracket || buf.second != "}") {
+                el.add_error(ErrCode::Unexpected, lookUp.pos(), buf.second);
+                goto DECL_DONE;
             }
+
+            auto lowered = c_func->gen_code();
+            if (env.vectorize_)
+                vec::vectorize(lowered);
+            if (env.dump_ir_) {
+                std::cout << "*** Lowered: " << c_func->name_ << '\n';
+                lowered.dump(std::cout);
+            }
+            codes.push_back(std::move(c_func));
         }
-        if (buf.first == Token::Separator) {
+        else if (buf.first == Token::Separator) {
             std::string ns = std::move(name);
 
+            eat(Token::Separator);
             buf = eat();
         PARSE_NS:
             if (buf.first == Token::Identifier) {
                 ns += ';' + std::move(buf.second);
-                buf = eat(Token::Separator);
+                eat(Token::Separator);
+                buf = eat();
                 goto PARSE_NS;
             }
-            if (buf.first == Token::Bracket) {
-                if (buf.second != "{") {
-                    el.add_error({ {}, "Expected '{'" });
-                    continue;
-                }
+            if (buf.first != Token::Bracket || buf.second != "{") {
+                el.add_error(ErrCode::Expected, lookUp.pos(), "{");
+                goto DECL_DONE;
             }
+            ++ns_depth;
 
             // parse namespaces
             std::cout << "NAMESPACE: " << ns << '\n';
         }
-
-        if (buf.first == Token::From || buf.first == Token::Bracket) {
+        else if (buf.first == Token::From || buf.first == Token::Bracket) {
             // parse class
+            // name from base, ... { hot name: ty, ... }
             std::cout << "CLASS: " << name << '\n';
+
+            std::vector<std::string> bases{};
+            if (buf.first == Token::From) {
+                eat(Token::From);
+            PARSE_BASE:
+                bases.push_back(eat(Token::Identifier).second);
+                if (look().first == Token::Comma) {
+                    eat();
+                    goto PARSE_BASE;
+                }
+            }
+
+            buf = eat(Token::Bracket);
+            if (buf.second != "{") {
+                el.add_error(ErrCode::Expected, lookUp.pos(), "{");
+                goto DECL_DONE;
+            }
+
+            std::vector<layout::Field> fields{};
+        PARSE_FIELD:
+            buf = eat();
+            if (buf.first == Token::Comma)
+                goto PARSE_FIELD;
+            if (buf.first == Token::Identifier) {
+                layout::Field f{ {}, {}, false };
+                if (buf.second == "hot" && look().first == Token::Identifier) {
+                    f.hot_ = true;
+                    buf = eat();
+                }
+                f.name_ = std::move(buf.second);
+                eat(Token::TypeOf);
+                f.type_ = std::move(expect_type().second);
+                fields.push_back(std::move(f));
+                goto PARSE_FIELD;
+            }
+            if (buf.first != Token::Bracket || buf.second != "}") {
+                el.add_error(ErrCode::UnexpectedToken, lookUp.pos(), buf.first, "}");
+                goto DECL_DONE;
+            }
+
+            auto l = layouts.lay_out(std::move(name), bases, std::move(fields));
+            if (!l) {
+                // reported at the class name, the class is parsed by now
+                el.add_error(l.error().first, decl, l.error().second);
+                goto DECL_DONE;
+            }
+            auto c_class = std::make_unique<Class>(**l);
+            if (env.dump_layout_)
+                c_class->dump_info(std::cout);
+            codes.push_back(std::move(c_class));
         }
+        else
+            el.add_error(ErrCode::Unexpected, lookUp.pos(), buf.second);
 
-        break;
+    DECL_DONE:
+        if (el.size() != decl_errs)
+            skip_decl(decl);
     }
+    if (ns_depth)
+        el.add_error(ErrCode::Expected, lookUp.pos(), "}");
 
-    return {{}, el};
+    return { std::move(codes), el };
 }
 
 } // ns code
+
+namespace bench {
+// -bench-vectorize
+// runs the same lowered pipelines per integer width: element by element
+// as without the vectorizer, then in blocks with the scalar kernels, then
+// in blocks with the simd kernels. the speedup is simd over scalar blocks
+int vectorize(std::ostream& os) noexcept {
+    using namespace zpp::code;
+    using Stage = ERangePipeline::Stage;
+    using Kind = Stage::Kind;
+
+    constexpr std::size_t n = 1 << 20;
+    constexpr int runs = 5;
+
+    const std::pair<std::string, std::vector<Stage>> kernels[]{
+        { "map", {
+            { Kind::Transform, {}, "+", 7 },
+            { Kind::Transform, {}, "^", 85 },
+            { Kind::Transform, {}, "-", 3 } } },
+        { "reduce", {
+            { Kind::Filter, {}, "%", 2 },
+            { Kind::Transform, {}, "+", 3 },
+            { Kind::Reduce, {}, "+", 0 } } },
+        { "max", {
+            { Kind::Filter, {}, ">", 0 },
+            { Kind::Reduce, {}, "max", 0 } } },
+    };
+
+    const auto best_isa = simd::isa();
+    os << "isa: " << simd::stringify_isa(best_isa) << ", " << n << " elements, best of " << runs << '\n'
+        << "type  kernel  per-elem(ms)  block(ms)   simd(ms)  speedup\n"
+        << std::fixed << std::setprecision(2);
+
+    bool ok = true;
+    auto bench = [&]<typename T>(T, const std::string& ty) {
+        std::vector<T> xs(n);
+        std::minstd_rand rng{ 42 };
+        for (auto& x : xs) x = static_cast<T>(rng());
+
+        for (const auto& [name, stages] : kernels) {
+            ERangePipeline p{ "xs", '[' + ty + ']' };
+            p.stages_ = stages;
+            CodeBlock scalar = p.lower_into("ret");
+            CodeBlock vectorized = p.lower_into("ret");
+            vec::vectorize(vectorized);
+            scalar.emit({ CodeBlock::Op::Ret, "ret" });
+            vectorized.emit({ CodeBlock::Op::Ret, "ret" });
+
+            // ret is left empty if any run fails
+            auto time = [&](const CodeBlock& cb, simd::Isa i, std::optional<exec::Value>& ret) {
+                simd::use_isa(i);
+                double best = std::numeric_limits<double>::max();
+                for (int r = 0; r < runs; ++r) {
+                    exec::Env env{ { "xs", xs } };
+                    const auto t0 = std::chrono::steady_clock::now();
+                    auto v = exec::run(cb, env);
+                    const auto t1 = std::chrono::steady_clock::now();
+                    if (!v) {
+                        ret.reset();
+                        break;
+                    }
+                    ret = std::move(*v);
+                    best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                }
+                simd::use_isa(best_isa);
+                return best;
+            };
+
+            std::optional<exec::Value> er{}, br{}, vr{};
+            const auto et = time(scalar, best_isa, er);
+            const auto bt = time(vectorized, simd::Isa::Scalar, br);
+            const auto vt = time(vectorized, best_isa, vr);
+            os << std::left << std::setw(6) << ty << std::setw(8) << name << std::right
+                << std::setw(12) << et << std::setw(11) << bt << std::setw(11) << vt
+                << std::setw(8) << bt / vt << 'x';
+            if (!er || er != br || er != vr) {
+                os << "  MISMATCH";
+                ok = false;
+            }
+            os << '\n';
+        }
+    };
+    bench(std::int8_t{}, "i8");
+    bench(std::int16_t{}, "i16");
+    bench(std::int32_t{}, "i32");
+    bench(std::int64_t{}, "i64");
+    return ok ? 0 : -1;
+}
+} // ns bench
+
 namespace init {
 
 // not meaning the function does compile
@@ -669,12 +2661,41 @@ int compile_zpp(compile_env&& env) noexcept {
     if(toks.has_value()) {
         //std::cout << toks.value().begin()->second << '\n';
         auto codes = code::make_codeblocks(std::move(env), std::move(toks.value()));
-        return 0;
+        if (codes.second.empty())
+            return 0;
+        codes.second.emit();
+        return -1;
     }
     std::cerr << toks.error().what() << '\n';
     return -1;
 }
 
+// the sources are read and lexed concurrently, then parsed in order
+int compile_zpps(compile_env&& env) noexcept {
+    std::vector<std::filesystem::path> paths{ env.source_path_ };
+    paths.insert(paths.end(), env.other_sources_.begin(), env.other_sources_.end());
+
+    auto toks = tok::tokenize_files(paths);
+
+    int ret = 0;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (!toks[i].has_value()) {
+            std::cerr << toks[i].error().what() << '\n';
+            ret = -1;
+            continue;
+        }
+        auto file_env = env;
+        file_env.source_path_ = paths[i];
+        file_env.other_sources_.clear();
+        auto codes = code::make_codeblocks(std::move(file_env), std::move(toks[i].value()));
+        if (!codes.second.empty()) {
+            codes.second.emit();
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
 int run_build_conf(init::compile_env&& env) noexcept {
     // TODO: someday.
 
@@ -691,6 +2712,8 @@ int parse_zpp(init::compile_env&& env) noexcept {
     if (std::ranges::starts_with(std::views::reverse(pth.string()), std::views::reverse("build.zpp"sv)))
         return run_build_conf(std::move(env));
 
+    if (!env.other_sources_.empty())
+        return compile_zpps(std::move(env));
     return compile_zpp(std::move(env));
 }
 } // ns zpp
@@ -705,17 +2728,30 @@ int main(int c, char** v) {
 
     if (cmd.is_help() || c == 1) {
         std::cout <<
-            "usage: zpp [SOURCE] [OPTIONS]\n"
-            "[SOURCE]       : Either run build.zpp or compile *.zpp\n"
+            "usage: zpp [SOURCE]... [OPTIONS]\n"
+            "[SOURCE]       : Either run build.zpp or compile *.zpp,\n"
+            "                 several *.zpp are read and lexed concurrently\n"
             "[OPTIONS]\n"
             "-h             : Show zpp compiler usage\n"
             "-std={VERSION} : Set the zpp compiler version\n"
+            "-dump-layout   : Print the memory layout of every class\n"
+            "-fpack-fields  : Reorder class fields to minimize padding,\n"
+            "                 keeping `hot` fields within the same cache line\n"
+            "-dump-ir       : Print the lowered code of every function\n"
+            "-fno-vectorize : Keep loops over integer ranges scalar\n"
+            "-fdiagnostics-format={text|json}\n"
+            "               : Print errors as text, or as one json object per line\n"
+            "-bench-vectorize : Time scalar against vectorized loops\n"
+            "                 for every integer width, then exit\n"
             "Zpp Versions:\n"
             "   Zpp24\n"
             ;
         return 0;
     }
 
+    if (cmd.has_flag("-bench-vectorize"))
+        return zpp::bench::vectorize(std::cout);
+
     wchar_t* data = (wchar_t*)malloc(sizeof(wchar_t) * MAX_PATH);
 
     if (!cmd.has_source()) {